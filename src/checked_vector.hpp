@@ -11,26 +11,31 @@
 
 #include <vector>
 #include <cstddef>
+#include <memory>
+#include <utility>
 
 /** Derives std::vector and adds checks for out-of-bounds
  */
-	template<class T>
-	class checked_vector : public std::vector<T>
+	template<class T, class Alloc = std::allocator<T>>
+	class checked_vector : public std::vector<T, Alloc>
 	{
 		public:
-		checked_vector(size_t _size) : std::vector<T>(_size) {}
-		checked_vector(const checked_vector<T>& pol) : std::vector<T>(pol) {}
-		checked_vector() : std::vector<T>() {}
+		checked_vector(size_t _size) : std::vector<T, Alloc>(_size) {}
+		checked_vector(const checked_vector<T, Alloc>& pol) : std::vector<T, Alloc>(pol) {}
+		checked_vector(checked_vector<T, Alloc>&& pol) : std::vector<T, Alloc>(std::move(pol)) {}
+		checked_vector& operator=(const checked_vector<T, Alloc>& pol) { std::vector<T, Alloc>::operator=(pol); return *this; }
+		checked_vector& operator=(checked_vector<T, Alloc>&& pol) { std::vector<T, Alloc>::operator=(std::move(pol)); return *this; }
+		checked_vector() : std::vector<T, Alloc>() {}
 //		checked_vector(typename std::vector<T>::size_type n, const typename std::vector<T>::value_type& val = std::vector<T>::value_type()) 
 //			: std::vector<T>(n, val) { }
 #ifndef NDEBUG
 		T& operator[](size_t n) noexcept { 
 			DCHECK_LT(n, this->size());
-			return std::vector<T>::at(n); 
+			return std::vector<T, Alloc>::at(n); 
 		}
 		const T& operator[](size_t n) const noexcept { 
 			DCHECK_LT(n, this->size());
-			return std::vector<T>::at(n);
+			return std::vector<T, Alloc>::at(n);
 		}
 #endif
 	};
@@ -0,0 +1,662 @@
+/**
+ * @file external_sa.hpp
+ * @brief External memory construction of the suffix array and the LCP array
+ *
+ * The suffix array is computed block-wise from right to left, where the size of a block is bounded by a memory budget.
+ * The suffixes starting in a block are sorted in RAM with saisxx, and merged into the suffix array of the suffixes
+ * right of the block by counting for each of these how many suffixes of the block are smaller.
+ * These counts are computed by backward search with the BWT of the block while streaming the text from right to left.
+ * This takes O(n^2 / block size) sequential I/O, independent of how repetitive the text is.
+ * A block takes at most 30 bytes per position when indexed by int (up to 2^30 positions), and 42 bytes beyond.
+ * @author Kärkkäinen, Kempa and Puglisi, "Parallel External Memory Suffix Sorting", CPM'15 (simplified)
+ *
+ * The LCP array is computed with the irreducible values of the permuted LCP array, whose sum is O(n log n).
+ * The comparisons of the text needed for them are sorted, such that the text is read block by block
+ * for the one side and streamed for the other side of a comparison, and never accessed at random.
+ * @author Kärkkäinen and Kempa, "LCP Array Construction in External Memory", SEA'14
+ *
+ * Only a block of the text is held in RAM. The text file is memory mapped to read it.
+ *
+ * The arrays are written as raw files of 64-bit unsigned integers in native byte order,
+ * such that they can be read sequentially or by seeking.
+ */
+#ifndef EXTERNAL_SA_HPP
+#define EXTERNAL_SA_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <queue>
+#include <algorithm>
+#include <type_traits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+/**
+ * An anonymous temporary file in a given directory. It is unlinked right after its creation,
+ * such that it gets removed when closed.
+ */
+class TempFile {
+	int m_fd;
+	public:
+	TempFile(const std::string& directory) {
+		std::string path = directory + "/strinalyze.XXXXXX";
+		m_fd = mkstemp(&path[0]);
+		PCHECK(m_fd != -1) << "Could not create a temporary file in " << directory;
+		unlink(path.c_str());
+	}
+	TempFile(TempFile&& other) : m_fd(other.m_fd) {
+		other.m_fd = -1;
+	}
+	TempFile& operator=(TempFile&& other) {
+		std::swap(m_fd, other.m_fd);
+		return *this;
+	}
+	TempFile(const TempFile&) = delete;
+	TempFile& operator=(const TempFile&) = delete;
+	~TempFile() {
+		if(m_fd != -1) close(m_fd);
+	}
+	int fd() const {
+		return m_fd;
+	}
+};
+
+/** Buffered appending of elements to a file descriptor */
+template<class T>
+class FileWriter {
+	const int m_fd;
+	std::vector<T> m_buffer;
+	public:
+	static constexpr size_t buffer_elements = (1ULL<<20)/sizeof(T);
+
+	FileWriter(int fd) : m_fd(fd) {
+		m_buffer.reserve(buffer_elements);
+	}
+	~FileWriter() {
+		flush();
+	}
+	void push(const T& element) {
+		m_buffer.push_back(element);
+		if(m_buffer.size() == buffer_elements) flush();
+	}
+	void flush() {
+		const char* data = reinterpret_cast<const char*>(m_buffer.data());
+		size_t remaining = m_buffer.size()*sizeof(T);
+		while(remaining > 0) {
+			const ssize_t written = write(m_fd, data, remaining);
+			PCHECK(written > 0) << "Could not write to file";
+			data += written;
+			remaining -= written;
+		}
+		m_buffer.clear();
+	}
+};
+
+/**
+ * Buffered reading of count elements of a file starting at the offset-th element.
+ * Uses pread, such that several readers can share the same file descriptor.
+ */
+template<class T>
+class FileReader {
+	const int m_fd;
+	uint64_t m_offset; //!< file position in bytes of the next element not yet buffered
+	uint64_t m_remaining; //!< number of elements not yet buffered
+	std::vector<T> m_buffer;
+	size_t m_position = 0;
+	public:
+	FileReader(int fd, uint64_t offset, uint64_t count, size_t buffer_elements = (1ULL<<20)/sizeof(T))
+		: m_fd(fd), m_offset(offset*sizeof(T)), m_remaining(count)
+	{
+		m_buffer.reserve(std::max<size_t>(1, buffer_elements));
+	}
+	bool empty() const {
+		return m_position == m_buffer.size() && m_remaining == 0;
+	}
+	T next() {
+		if(m_position == m_buffer.size()) fill();
+		return m_buffer[m_position++];
+	}
+	private:
+	void fill() {
+		DCHECK_GT(m_remaining, 0);
+		const size_t elements = std::min<uint64_t>(m_remaining, m_buffer.capacity());
+		m_buffer.resize(elements);
+		char* data = reinterpret_cast<char*>(m_buffer.data());
+		size_t remaining = elements*sizeof(T);
+		while(remaining > 0) {
+			const ssize_t got = pread(m_fd, data, remaining, m_offset);
+			PCHECK(got > 0) << "Could not read from file";
+			data += got;
+			remaining -= got;
+			m_offset += got;
+		}
+		m_remaining -= elements;
+		m_position = 0;
+	}
+};
+
+/** Buffered appending of bits to a file descriptor, packed into 64-bit words */
+class BitWriter {
+	FileWriter<uint64_t> m_writer;
+	uint64_t m_word = 0;
+	size_t m_bits = 0;
+	public:
+	BitWriter(int fd) : m_writer(fd) {}
+	~BitWriter() {
+		if(m_bits > 0) m_writer.push(m_word);
+	}
+	void push(bool bit) {
+		m_word |= static_cast<uint64_t>(bit) << m_bits;
+		if(++m_bits == 64) {
+			m_writer.push(m_word);
+			m_word = 0;
+			m_bits = 0;
+		}
+	}
+};
+
+/** Buffered reading of the first count bits written by a BitWriter */
+class BitReader {
+	FileReader<uint64_t> m_reader;
+	uint64_t m_word = 0;
+	size_t m_bits = 64;
+	public:
+	BitReader(int fd, uint64_t count) : m_reader(fd, 0, (count+63)/64) {}
+	bool next() {
+		if(m_bits == 64) {
+			m_word = m_reader.next();
+			m_bits = 0;
+		}
+		return (m_word >> m_bits++) & 1;
+	}
+};
+
+/**
+ * Sorts a stream of elements with a bounded buffer.
+ * Whenever the buffer is full, it is sorted and written as a run to a temporary file.
+ * The runs are finally merged with a heap. If all elements fit into the buffer, no file is written.
+ */
+template<class T, class Compare>
+class ExternalSorter {
+	const size_t m_memory;
+	const std::string& m_tmpdir;
+	const Compare m_compare;
+	std::vector<T> m_buffer;
+	std::vector<TempFile> m_runfile; //!< at most one file holding all runs consecutively
+	std::vector<std::pair<uint64_t,uint64_t>> m_runs; //!< (offset, length) in elements of each run
+
+	public:
+	/**
+	 * @param memory budget in bytes for the buffer
+	 * @param tmpdir directory for the runs
+	 */
+	ExternalSorter(size_t memory, const std::string& tmpdir, Compare compare = Compare())
+		: m_memory(memory), m_tmpdir(tmpdir), m_compare(compare)
+	{}
+	void push(const T& element) {
+		if(m_buffer.capacity() == 0) m_buffer.reserve(capacity()); // growing it would need up to 1.5 times the memory
+		if(m_buffer.size() >= capacity()) spill();
+		m_buffer.push_back(element);
+	}
+	bool empty() const {
+		return m_buffer.empty() && m_runs.empty();
+	}
+	/**
+	 * Calls f for each element in sorted order. The sorter is exhausted afterwards.
+	 */
+	template<class F>
+	void for_each(F f) {
+		if(m_runs.empty()) {
+			std::sort(m_buffer.begin(), m_buffer.end(), m_compare);
+			for(const T& element : m_buffer) f(element);
+			std::vector<T>().swap(m_buffer);
+			return;
+		}
+		spill();
+		std::vector<T>().swap(m_buffer);
+		std::vector<FileReader<T>> readers;
+		readers.reserve(m_runs.size());
+		const size_t buffer_elements = capacity() / m_runs.size();
+		for(const auto& run : m_runs) {
+			readers.emplace_back(m_runfile[0].fd(), run.first, run.second, buffer_elements);
+		}
+		auto greater = [&] (const std::pair<T,size_t>& a, const std::pair<T,size_t>& b) { return m_compare(b.first, a.first); };
+		std::priority_queue<std::pair<T,size_t>, std::vector<std::pair<T,size_t>>, decltype(greater)> heap(greater);
+		for(size_t i = 0; i < readers.size(); ++i) {
+			heap.emplace(readers[i].next(), i);
+		}
+		while(!heap.empty()) {
+			const std::pair<T,size_t> top = heap.top();
+			heap.pop();
+			f(top.first);
+			if(!readers[top.second].empty()) heap.emplace(readers[top.second].next(), top.second);
+		}
+		m_runs.clear();
+		m_runfile.clear();
+	}
+
+	private:
+	size_t capacity() const {
+		return std::max<size_t>(1, m_memory/sizeof(T));
+	}
+	void spill() {
+		if(m_buffer.empty()) return;
+		if(m_runfile.empty()) m_runfile.emplace_back(m_tmpdir);
+		std::sort(m_buffer.begin(), m_buffer.end(), m_compare);
+		const uint64_t offset = m_runs.empty() ? 0 : m_runs.back().first + m_runs.back().second;
+		{
+			FileWriter<T> writer(m_runfile[0].fd());
+			for(const T& element : m_buffer) writer.push(element);
+		}
+		m_runs.emplace_back(offset, m_buffer.size());
+		m_buffer.clear();
+	}
+};
+
+/** read-only memory mapping of a file */
+class MappedText {
+	const char* m_data = nullptr;
+	uint64_t m_size = 0;
+	public:
+	MappedText(const std::string& path) {
+		const int fd = open(path.c_str(), O_RDONLY);
+		PCHECK(fd != -1) << "Could not open " << path;
+		struct stat st;
+		PCHECK(fstat(fd, &st) == 0) << "Could not stat " << path;
+		m_size = st.st_size;
+		if(m_size > 0) {
+			void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			PCHECK(data != MAP_FAILED) << "Could not map " << path;
+			m_data = static_cast<const char*>(data);
+		}
+		close(fd);
+	}
+	MappedText(const MappedText&) = delete;
+	MappedText& operator=(const MappedText&) = delete;
+	~MappedText() {
+		if(m_data != nullptr) munmap(const_cast<char*>(m_data), m_size);
+	}
+	uint64_t size() const {
+		return m_size;
+	}
+	unsigned char operator[](uint64_t i) const {
+		DCHECK_LT(i, m_size);
+		return m_data[i];
+	}
+};
+
+struct ExternalPair {
+	uint64_t first;
+	uint64_t second;
+};
+struct ExternalTriple {
+	uint64_t first;
+	uint64_t second;
+	uint64_t third;
+};
+struct ExternalByFirst {
+	template<class T>
+	bool operator()(const T& a, const T& b) const {
+		return a.first < b.first;
+	}
+};
+
+/** A comparison of the suffix T[position..] with T[predecessor..], whose first `matched` characters are known to be equal */
+struct ExternalComparison {
+	uint64_t position;
+	uint64_t predecessor;
+	uint64_t matched;
+};
+/** orders comparisons by the next character to read of T[predecessor..] */
+struct ExternalByPredecessor {
+	bool operator()(const ExternalComparison& a, const ExternalComparison& b) const {
+		return a.predecessor + a.matched < b.predecessor + b.matched;
+	}
+};
+/** orders comparisons by the next character to read of T[position..] */
+struct ExternalByPosition {
+	bool operator()(const ExternalComparison& a, const ExternalComparison& b) const {
+		return a.position + a.matched < b.position + b.matched;
+	}
+};
+
+namespace external_sa_private {
+	/** number of rows of the BWT of a block between two samples of the character occurrences */
+	constexpr size_t rank_sampling = 128;
+	/** memory of the buffers of the reader and the writer streaming alongside the arrays of a block */
+	constexpr size_t stream_buffers = 2*(1ULL<<20);
+	/** largest block indexed by int, such that saisxx can index it and its Z-array fits into 32-bit integers. Larger blocks are indexed by int64_t */
+	constexpr uint64_t max_int_block_size = 1ULL<<30;
+
+	/**
+	 * Returns the freed memory to the operating system. glibc keeps freed arrays smaller than its mmap threshold (up to 32 MiB),
+	 * such that the arrays of the blocks fragment its heap and add to the memory used by the arrays alive.
+	 */
+	inline void trim_heap() {
+#ifdef __GLIBC__
+		malloc_trim(0);
+#endif
+	}
+
+	/**
+	 * Peak memory in bytes per text position of a block indexed by index_type, which is the maximum of
+	 * sorting it: its text with the lookahead (2), the ranks of the tail (8), the names (4), and
+	 * the Z-array (2 index_type), or later the suffix array and the buckets of saisxx' recursion (at most 1.5 index_type);
+	 * and merging it: its text (1), suffix array (1 index_type), BWT (1), rank samples (256/rank_sampling index_type),
+	 * gap array (8) and the ranks for the next block (8), which overwrite the ranks of the tail.
+	 * The buffers for streaming come on top, see stream_buffers.
+	 */
+	template<class index_type>
+	constexpr size_t bytes_per_position() {
+		return 2+8+4 + 2*sizeof(index_type) > 1+sizeof(index_type)+1 + 256/rank_sampling*sizeof(index_type) + 8+8
+			? 2+8+4 + 2*sizeof(index_type)
+			: 1+sizeof(index_type)+1 + 256/rank_sampling*sizeof(index_type) + 8+8;
+	}
+
+	/**
+	 * Sorts the suffixes of the text T starting in the block T[s..e), where the suffixes starting at e or later are already sorted.
+	 * Each character equal to T[e] is named by whether its suffix is larger than T[e..], such that saisxx
+	 * on the block followed by T[e] (as a name smaller than the larger and larger than the smaller of them) sorts the suffixes
+	 * as in the whole text: a suffix T[j..] of the block whose part T[j..e) is a prefix of T[i..] compares like T[e..] to T[i+e-j..].
+	 *
+	 * Whether T[s+k..] is larger than T[e..] follows from their longest common prefix computed with the Z-algorithm up to length e-s,
+	 * and from the ranks of T[e+k..] and T[e+(e-s)..] in the suffix array of T[e..] if they share a longer prefix.
+	 *
+	 * @param buffer T[s..e+m), where m = min(e-s, n-e) 
+	 * @param length the block length e-s
+	 * @param text_ends whether e+m = n
+	 * @param tail_ranks tail_ranks[x] is the rank of T[e+x..] in the suffix array of T[e..] for 0 <= x <= e-s, only needed if not text_ends
+	 * @return the suffix array of the block, with positions relative to s
+	 */
+	template<class index_type>
+	std::vector<index_type> sort_block(const std::string& buffer, size_t length, bool text_ends, const std::vector<uint64_t>& tail_ranks) {
+		const size_t m = buffer.size() - length;
+		std::vector<int> names(length+1);
+		if(m == 0) { // the block ends with the text, the empty suffix follows
+			for(size_t k = 0; k < length; ++k) names[k] = 3*static_cast<unsigned char>(buffer[k])+1;
+			names[length] = 0;
+		} else {
+			// Z-array of T[e..e+m) T[s..e+m), where z[m+k] is the longest common prefix of T[s+k..] and T[e..] as long as it is less than m
+			auto character = [&] (size_t x) { return x < m ? buffer[length+x] : buffer[x-m]; };
+			const size_t total = 2*m + length;
+			std::vector<typename std::make_unsigned<index_type>::type> z(m + length);
+			for(size_t x = 1, left = 0, right = 0; x < z.size(); ++x) {
+				size_t matched = x < right ? std::min<size_t>(right-x, z[x-left]) : 0;
+				while(x+matched < total && character(matched) == character(x+matched)) ++matched;
+				z[x] = matched;
+				if(x+matched > right) {
+					left = x;
+					right = x+matched;
+				}
+			}
+			const unsigned char head = buffer[length];
+			for(size_t k = 0; k < length; ++k) {
+				const unsigned char c = buffer[k];
+				if(c != head) {
+					names[k] = 3*c+1;
+					continue;
+				}
+				const size_t matched = std::min<size_t>(z[m+k], m);
+				bool larger; // T[s+k..] > T[e..]
+				if(matched < m) larger = static_cast<unsigned char>(buffer[k+matched]) > static_cast<unsigned char>(buffer[length+matched]);
+				else if(text_ends) larger = true;
+				else larger = tail_ranks[k] > tail_ranks[length];
+				names[k] = 3*c + 2*larger;
+			}
+			names[length] = 3*head+1;
+		}
+		std::vector<index_type> sa(length+1);
+		// as saisxx, whose literal 0 for the free space cannot be deduced as a 64-bit index_type; a block has at least two suffixes
+		saisxx_private::suffixsort<std::vector<int>::const_iterator, typename std::vector<index_type>::iterator, index_type>(names.cbegin(), sa.begin(), 0, length+1, 3*256, false);
+		sa.erase(std::find(sa.begin(), sa.end(), static_cast<index_type>(length)));
+		return sa;
+	}
+
+	/**
+	 * Sorts the suffixes of the text block-wise from right to left, merging each block into the suffix array of the suffixes
+	 * starting right of it, called the tail T[e..].
+	 * @param block_size number of text positions of a block, see bytes_per_position
+	 * @param counts receives the occurrences of each character in the text
+	 * @return a file storing the suffix array
+	 */
+	template<class index_type>
+	TempFile sort_blockwise(const MappedText& text, uint64_t block_size, const std::string& tmpdir, std::vector<uint64_t>& counts) {
+		typedef typename std::make_unsigned<index_type>::type unsigned_index;
+		const uint64_t n = text.size();
+		TempFile order(tmpdir);   // the suffix array of the tail
+		TempFile larger(tmpdir);  // the (n-1-p)-th bit tells whether T[p..] > T[e..] for each p >= e
+		// rank of T[e+x..] in the suffix array of the tail for 0 <= x <= block_size, needed to sort a block.
+		// It is overwritten while merging by the ranks needed by the next block, such that both share the memory.
+		std::vector<uint64_t> ranks;
+		for(uint64_t blocks = (n + block_size - 1) / block_size; blocks > 0; --blocks) {
+			trim_heap(); // the arrays of the previous block
+			const uint64_t s = (blocks-1)*block_size;
+			const uint64_t e = std::min(n, s+block_size);
+			const size_t length = e-s;
+			std::string buffer(length + std::min<uint64_t>(length, n-e), 0);
+			for(size_t k = 0; k < buffer.size(); ++k) buffer[k] = text[s+k];
+			const std::vector<index_type> sa = sort_block<index_type>(buffer, length, s+buffer.size() == n, ranks);
+			trim_heap(); // the names and the Z-array
+			buffer.resize(length);
+			buffer.shrink_to_fit();
+
+			// BWT of the block, where the row of T[s..] gets the character zero
+			size_t first = 0; // rank of T[s..] among the suffixes of the block
+			std::string bwt(length, 0);
+			for(size_t r = 0; r < length; ++r) {
+				if(sa[r] == 0) first = r;
+				else bwt[r] = buffer[sa[r]-1];
+			}
+			std::vector<uint64_t> smaller(256, 0); // smaller[c] is the number of suffixes of the block starting with a character less than c
+			for(const char c : buffer) ++smaller[static_cast<unsigned char>(c)];
+			for(size_t c = 0, sum = 0; c < 256; ++c) {
+				const uint64_t count = smaller[c];
+				counts[c] += count;
+				smaller[c] = sum;
+				sum += count;
+			}
+			std::vector<unsigned_index> samples((length/rank_sampling + 1) * 256); // occurrences of each character in bwt[0..k*rank_sampling) for each k
+			{
+				std::vector<unsigned_index> running(256, 0);
+				for(size_t r = 0; r <= length; ++r) {
+					if(r % rank_sampling == 0) std::copy(running.begin(), running.end(), samples.begin() + (r/rank_sampling)*256);
+					if(r < length) ++running[static_cast<unsigned char>(bwt[r])];
+				}
+			}
+			// number of rows before r whose BWT character is c, not counting the row of T[s..]
+			auto occurrences = [&] (unsigned char c, size_t r) {
+				const size_t sample = r / rank_sampling;
+				uint64_t count = samples[sample*256 + c];
+				for(size_t k = sample*rank_sampling; k < r; ++k) count += static_cast<unsigned char>(bwt[k]) == c;
+				return count - (c == 0 && r > first);
+			};
+
+			// streams the tail from right to left, counting the suffixes of the block smaller than T[p..] by backward search:
+			// T[i..] < T[p..] iff T[i] < T[p] or T[i] = T[p] and T[i+1..] < T[p+1..], where T[e..] < T[p+1..] is read from the bits of the previous block.
+			// gap[r] is the number of suffixes of the tail larger than exactly r suffixes of the block
+			std::vector<uint64_t> gap(length+1, 0);
+			TempFile next_larger(tmpdir);
+			{
+				BitWriter next_bits(next_larger.fd());
+				BitReader bits(larger.fd(), n-e);
+				const unsigned char last = buffer[length-1];
+				uint64_t rank = 0; // number of suffixes of the block smaller than T[p..]
+				bool follows = false; // T[p..] > T[e..]
+				for(uint64_t p = n; p > e; --p) {
+					const unsigned char c = text[p-1];
+					rank = smaller[c] + occurrences(c, rank) + (c == last && follows);
+					++gap[rank];
+					next_bits.push(rank > first);
+					follows = bits.next();
+				}
+				std::vector<bool> block_larger(length, false);
+				for(size_t r = first+1; r < length; ++r) block_larger[sa[r]] = true;
+				for(size_t k = length; k > 0; --k) next_bits.push(block_larger[k-1]);
+			}
+
+			// merges the block into the suffix array of the tail, recording the ranks needed by the next block
+			TempFile next_order(tmpdir);
+			ranks.resize(s > 0 ? block_size+1 : 0);
+			{
+				FileWriter<uint64_t> writer(next_order.fd());
+				FileReader<uint64_t> reader(order.fd(), 0, n-e);
+				uint64_t rank = 0;
+				auto push = [&] (uint64_t position) {
+					if(position - s < ranks.size()) ranks[position - s] = rank;
+					writer.push(position);
+					++rank;
+				};
+				for(size_t r = 0; r <= length; ++r) {
+					for(uint64_t g = 0; g < gap[r]; ++g) push(reader.next());
+					if(r < length) push(s + sa[r]);
+				}
+			}
+			order = std::move(next_order);
+			larger = std::move(next_larger);
+			VLOG(1) << "sorted the suffixes starting at " << s << " or later";
+		}
+		return order;
+	}
+}
+
+/**
+ * Computes the suffix array and the LCP array of the text stored in a file,
+ * and writes them to output_prefix.sa and output_prefix.lcp.
+ * Each array is written as a sequence of 64-bit unsigned integers with the same semantics as create_sa and create_lcp.
+ *
+ * @param text_path the file storing the text
+ * @param output_prefix prefix of the output files
+ * @param memory budget in bytes, determining the block sizes and the buffers of the external sorting
+ * @param tmpdir directory for the temporary files
+ * @param stripDollar Shall the delimiting $ be neglected? If not, it is the lexicographically smallest suffix.
+ */
+inline void construct_external_sa(const std::string& text_path, const std::string& output_prefix, size_t memory, const std::string& tmpdir, bool stripDollar) {
+	using namespace external_sa_private;
+	const MappedText text(text_path);
+	const uint64_t n = text.size();
+	const size_t usable_memory = memory > stream_buffers ? memory - stream_buffers : 0; // left for the arrays and the sorters
+	const uint64_t int_block_size = std::min<uint64_t>(max_int_block_size, usable_memory / bytes_per_position<int>());
+	const uint64_t wide_block_size = usable_memory / bytes_per_position<int64_t>();
+	std::vector<uint64_t> counts(256, 0); // occurrences of each character in the text
+	TempFile order = wide_block_size > int_block_size
+		? sort_blockwise<int64_t>(text, wide_block_size, tmpdir, counts)
+		: sort_blockwise<int>(text, std::max<uint64_t>(1, int_block_size), tmpdir, counts);
+
+	// writes the suffix array and collects (i, Phi[i], rank of T[i..]) with Phi[SA[r]] = SA[r-1], where Phi[SA[0]] = n
+	ExternalSorter<ExternalTriple, ExternalByFirst> phi(usable_memory/2, tmpdir);
+	{
+		const std::string sa_path = output_prefix + ".sa";
+		const int fd = open(sa_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		PCHECK(fd != -1) << "Could not create " << sa_path;
+		{
+			FileWriter<uint64_t> writer(fd);
+			if(!stripDollar) writer.push(n);
+			FileReader<uint64_t> reader(order.fd(), 0, n);
+			for(uint64_t r = 0, previous = n; r < n; ++r) {
+				const uint64_t position = reader.next();
+				writer.push(position);
+				phi.push(ExternalTriple { position, previous, r });
+				previous = position;
+			}
+		}
+		close(fd);
+	}
+
+	// The LCP value of T[i..] is irreducible unless Phi[i] = Phi[i-1]+1 and T[i-1..] shares its first character with T[Phi[i-1]..],
+	// which holds iff the rank of T[i-1..] does not start a bucket of the suffix array. Then PLCP[i] = PLCP[i-1]-1.
+	// The irreducible values sum up to O(n log n) and are computed by comparing characters.
+	std::vector<uint64_t> buckets; // ranks starting a bucket
+	for(uint64_t c = 0, sum = 0; c < 256; sum += counts[c++]) {
+		if(counts[c] > 0) buckets.push_back(sum);
+	}
+	TempFile ranks(tmpdir); // the inverse suffix array
+	ExternalSorter<ExternalComparison, ExternalByPredecessor> comparisons(usable_memory/4, tmpdir);
+	ExternalSorter<ExternalPair, ExternalByFirst> irreducible(usable_memory/4, tmpdir); // (i, PLCP[i]) for each irreducible i
+	{
+		FileWriter<uint64_t> writer(ranks.fd());
+		ExternalTriple previous { n, n, 0 };
+		phi.for_each([&] (const ExternalTriple& t) {
+			writer.push(t.third);
+			if(t.second == n) {
+				irreducible.push(ExternalPair { t.first, 0 });
+			} else if(previous.second == n || t.second != previous.second+1 || std::binary_search(buckets.begin(), buckets.end(), previous.third)) {
+				comparisons.push(ExternalComparison { t.first, t.second, 0 });
+			}
+			previous = t;
+		});
+	}
+
+	// compares the suffixes with their predecessors block by block: a block of the text holds the predecessors
+	// while the text is streamed for the suffixes, which are sorted by their positions.
+	// A comparison reaching the end of its block continues in the next block.
+	{
+		const uint64_t lcp_block_size = std::max<uint64_t>(1, usable_memory/4);
+		ExternalSorter<ExternalComparison, ExternalByPosition> first_pending(usable_memory/8, tmpdir);
+		ExternalSorter<ExternalComparison, ExternalByPosition> second_pending(usable_memory/8, tmpdir);
+		ExternalSorter<ExternalComparison, ExternalByPosition>* pending = &first_pending;
+		ExternalSorter<ExternalComparison, ExternalByPosition>* carried = &second_pending;
+		uint64_t begin = 0; // the block is T[begin..begin+lcp_block_size)
+		std::string block;
+		auto compare = [&] () {
+			if(pending->empty()) return;
+			const uint64_t end = std::min(n, begin + lcp_block_size);
+			block.resize(end-begin);
+			for(uint64_t k = begin; k < end; ++k) block[k-begin] = text[k];
+			pending->for_each([&] (ExternalComparison c) {
+				while(c.predecessor + c.matched < end && c.position + c.matched < n
+					&& text[c.position + c.matched] == static_cast<unsigned char>(block[c.predecessor + c.matched - begin])) {
+					++c.matched;
+				}
+				if(c.predecessor + c.matched == end && end < n && c.position + c.matched < n) carried->push(c);
+				else irreducible.push(ExternalPair { c.position, c.matched });
+			});
+			std::swap(pending, carried);
+		};
+		comparisons.for_each([&] (const ExternalComparison& c) {
+			for(; c.predecessor >= begin + lcp_block_size; begin += lcp_block_size) compare();
+			pending->push(c);
+		});
+		for(; !pending->empty(); begin += lcp_block_size) compare();
+	}
+
+	// computes PLCP in text order and sorts it by the ranks
+	ExternalSorter<ExternalPair, ExternalByFirst> lcp(usable_memory/2, tmpdir);
+	{
+		FileReader<uint64_t> rank_reader(ranks.fd(), 0, n);
+		uint64_t i = 0;
+		uint64_t h = 0;
+		auto reduce = [&] (uint64_t until) {
+			for(; i < until; ++i) {
+				DCHECK_GT(h, 0);
+				lcp.push(ExternalPair { rank_reader.next(), --h });
+			}
+		};
+		irreducible.for_each([&] (const ExternalPair& p) {
+			reduce(p.first);
+			h = p.second;
+			lcp.push(ExternalPair { rank_reader.next(), h });
+			++i;
+		});
+		reduce(n);
+	}
+	{
+		const std::string lcp_path = output_prefix + ".lcp";
+		const int fd = open(lcp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		PCHECK(fd != -1) << "Could not create " << lcp_path;
+		{
+			FileWriter<uint64_t> writer(fd);
+			if(!stripDollar) writer.push(0);
+			lcp.for_each([&] (const ExternalPair& p) { writer.push(p.second); });
+		}
+		close(fd);
+	}
+}
+
+#endif /* EXTERNAL_SA_HPP */
@@ -0,0 +1,133 @@
+/**
+ * @file generalized_sa.hpp
+ * @brief Generalized suffix array of a batch of strings
+ *
+ * Concatenates a batch of short strings, each terminated by a separator,
+ * and builds one suffix array for all of them.
+ * The suffix array, its inverse and the LCP array of each string are recovered from it,
+ * such that the per-call overhead of the construction is amortized over the batch.
+ * Needs saisxx to be declared beforehand.
+ */
+#ifndef GENERALIZED_SA_HPP
+#define GENERALIZED_SA_HPP
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <limits>
+
+template<class vektor_type>
+class GeneralizedSuffixArray {
+	public:
+	/** Terminates each string. It is smaller than all characters and takes the role of $. */
+	static constexpr char separator = 0;
+
+	private:
+	/** granularity of m_first_string */
+	static constexpr size_t window = 64;
+
+	std::string m_text;               //!< all strings, each followed by the separator
+	std::vector<size_t> m_offsets;    //!< m_offsets[k] is the starting position of the k-th string, m_offsets.back() = m_text.size()
+	std::vector<int> m_sa;
+	std::vector<size_t> m_first_string; //!< m_first_string[w] is the string containing the text position w*window
+
+	/** the string containing the text position pos, found by walking the offsets from the start of pos' window */
+	size_t string_at(size_t pos) const {
+		size_t k = m_first_string[pos / window];
+		while(m_offsets[k+1] <= pos) ++k;
+		return k;
+	}
+
+	public:
+	/**
+	 * Builds the generalized suffix array of a batch, reusing the buffers of the previous batch.
+	 * @param texts the strings of the batch, none of them may contain the separator
+	 */
+	void construct(const std::vector<std::string>& texts) {
+		size_t length = 0;
+		for(const std::string& t : texts) length += t.size()+1;
+		DCHECK_LT(length, static_cast<size_t>(std::numeric_limits<int>::max()));
+		m_text.clear();
+		m_text.reserve(length);
+		m_offsets.clear();
+		m_offsets.reserve(texts.size()+1);
+		m_first_string.clear();
+		for(const std::string& t : texts) {
+			DCHECK_EQ(t.find(separator), std::string::npos);
+			m_offsets.push_back(m_text.size());
+			m_text += t;
+			m_text += separator;
+			while(m_first_string.size()*window < m_text.size()) m_first_string.push_back(m_offsets.size()-1);
+		}
+		m_offsets.push_back(m_text.size());
+		const int n = m_text.size();
+		m_sa.resize(n);
+		if(n == 0) return;
+		using namespace saisxx_private;
+		saisxx<std::string::const_iterator, std::vector<int>::iterator, int>(m_text.cbegin(), m_sa.begin(), n);
+	}
+
+	/**
+	 * @return the number of strings in the batch
+	 */
+	size_t size() const {
+		return m_offsets.size()-1;
+	}
+
+	/**
+	 * @return the k-th string of the batch
+	 */
+	std::string text(size_t k) const {
+		return m_text.substr(m_offsets[k], m_offsets[k+1]-m_offsets[k]-1);
+	}
+
+	/**
+	 * Recovers the suffix array and its inverse of each string in one scan over the generalized suffix array,
+	 * and the LCP array of each string with Kasai et al. on its part of the concatenation.
+	 * Since the separators differ from all characters, these comparisons stop at the end of a string.
+	 *
+	 * @param stripDollar Shall the separator be neglected? If not, it becomes the $ of each string
+	 * @param sas receives the suffix array of each string
+	 * @param isas receives the inverse suffix array of each string
+	 * @param lcps receives the LCP array of each string
+	 */
+	void split(bool stripDollar, std::vector<vektor_type>& sas, std::vector<vektor_type>& isas, std::vector<vektor_type>& lcps) const {
+		const size_t strings = size();
+		sas.resize(strings);
+		isas.resize(strings);
+		lcps.resize(strings);
+		for(size_t k = 0; k < strings; ++k) {
+			const size_t length = m_offsets[k+1]-m_offsets[k] - stripDollar;
+			sas[k].resize(length);
+			isas[k].resize(length);
+			lcps[k].resize(length);
+		}
+		std::vector<size_t> filled(strings, 0);
+		for(size_t r = 0; r < m_sa.size(); ++r) {
+			const size_t pos = m_sa[r];
+			const size_t k = string_at(pos);
+			const size_t suffix = pos - m_offsets[k];
+			if(stripDollar && pos+1 == m_offsets[k+1]) continue;
+			isas[k][suffix] = filled[k];
+			sas[k][filled[k]++] = suffix;
+		}
+		for(size_t k = 0; k < strings; ++k) {
+			const char*const text = m_text.data() + m_offsets[k];
+			const vektor_type& sa = sas[k];
+			const vektor_type& isa = isas[k];
+			vektor_type& lcp = lcps[k];
+			if(lcp.empty()) continue;
+			lcp[0] = 0;
+			size_t h = 0;
+			for(size_t i = 0; i < lcp.size(); ++i) {
+				if(isa[i] == 0) continue;
+				const size_t j = sa[ isa[i] -1 ];
+				while(text[i+h] == text[j+h]) ++h;
+				lcp[isa[i]] = h;
+				h = h > 0 ? h-1 : 0;
+			}
+		}
+	}
+};
+
+#endif /* GENERALIZED_SA_HPP */
@@ -0,0 +1,138 @@
+/**
+ * @file lce.hpp
+ * @brief Longest common extension queries by range minimum queries on the LCP array
+ */
+#ifndef LCE_HPP
+#define LCE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <thread>
+
+/**
+ * Answers LCE(i,j), the length of the longest common prefix of the suffixes starting at i and j,
+ * in constant time by a range minimum query on the LCP array.
+ *
+ * The LCP array is split into blocks of 32 entries. A query spanning multiple blocks is answered
+ * by a sparse table on the block minima. Inside a block, the minimum is read from the stack of
+ * suffix minima stored as a bit mask for each position.
+ * @author Baumstark et al., "Practical Range Minimum Queries Revisited", SEA'17
+ * @tparam vektor_type type of the LCP array and the inverse suffix array
+ */
+template<class vektor_type>
+class LceQuery {
+	typedef typename vektor_type::value_type value_type;
+	static constexpr size_t block_size = 32;
+
+	const vektor_type& m_lcp;
+	const vektor_type& m_isa;
+	const size_t m_length; //!< length of the text without $
+	std::vector<uint32_t> m_stacks; //!< bit k of m_stacks[j] is set iff the k-th position of j's block is on the stack of suffix minima of the block after scanning j
+	std::vector<std::vector<value_type>> m_table; //!< m_table[k][b] = minimum of the blocks b..b+2^k)
+
+	static size_t log2(size_t x) {
+		return 8*sizeof(unsigned long long) - 1 - __builtin_clzll(x);
+	}
+
+	/** minimum of lcp[i..j] with i and j in the same block */
+	value_type block_minimum(size_t i, size_t j) const {
+		const uint32_t stack = m_stacks[j] & (~0U << (i % block_size));
+		return m_lcp[j - j % block_size + __builtin_ctz(stack)];
+	}
+
+	/** minimum of lcp[i..j] */
+	value_type minimum(size_t i, size_t j) const {
+		const size_t left = i / block_size;
+		const size_t right = j / block_size;
+		if(left == right) return block_minimum(i, j);
+		value_type result = std::min(block_minimum(i, (left+1)*block_size-1), block_minimum(right*block_size, j));
+		if(left+1 < right) {
+			const size_t k = log2(right-left-1);
+			result = std::min(result, std::min(m_table[k][left+1], m_table[k][right-(1ULL<<k)]));
+		}
+		return result;
+	}
+
+	/** LCE of the suffixes with ranks a and b */
+	size_t by_ranks(size_t a, size_t b) const {
+		if(a > b) std::swap(a, b);
+		return minimum(a+1, b);
+	}
+
+	public:
+	/**
+	 * @param lcp the LCP array
+	 * @param isa the inverse suffix array
+	 * @param length the length of the text, not counting a $
+	 */
+	LceQuery(const vektor_type& lcp, const vektor_type& isa, size_t length)
+		: m_lcp(lcp), m_isa(isa), m_length(length), m_stacks(lcp.size())
+	{
+		const size_t n = lcp.size();
+		const size_t blocks = (n + block_size - 1) / block_size;
+		std::vector<value_type> minima(blocks);
+		for(size_t b = 0; b < blocks; ++b) {
+			const size_t begin = b*block_size;
+			const size_t end = std::min(n, begin+block_size);
+			uint32_t stack = 0;
+			for(size_t j = begin; j < end; ++j) {
+				while(stack != 0 && m_lcp[begin + 31 - __builtin_clz(stack)] >= m_lcp[j]) {
+					stack &= ~(1U << (31 - __builtin_clz(stack)));
+				}
+				stack |= 1U << (j - begin);
+				m_stacks[j] = stack;
+			}
+			minima[b] = m_lcp[begin + __builtin_ctz(stack)];
+		}
+		m_table.push_back(std::move(minima));
+		for(size_t k = 1; (1ULL<<k) <= blocks; ++k) {
+			const std::vector<value_type>& previous = m_table[k-1];
+			const size_t half = 1ULL<<(k-1);
+			std::vector<value_type> level(blocks - (1ULL<<k) + 1);
+			for(size_t b = 0; b < level.size(); ++b) {
+				level[b] = std::min(previous[b], previous[b+half]);
+			}
+			m_table.push_back(std::move(level));
+		}
+	}
+
+	/**
+	 * @return the length of the longest common prefix of T[i..] and T[j..], zero if i or j is not a text position
+	 */
+	size_t operator()(size_t i, size_t j) const {
+		if(i >= m_length || j >= m_length) return 0;
+		if(i == j) return m_length - i;
+		return by_ranks(m_isa[i], m_isa[j]);
+	}
+
+	/**
+	 * Answers a batch of queries, split evenly among the given number of threads.
+	 *
+	 * @param queries pairs of text positions
+	 * @param answers receives the LCE of each pair
+	 * @param threads number of threads answering the queries
+	 */
+	void operator()(const std::vector<std::pair<size_t,size_t>>& queries, std::vector<size_t>& answers, size_t threads = 1) const {
+		answers.resize(queries.size());
+		auto answer = [&] (size_t begin, size_t end) {
+			for(size_t q = begin; q < end; ++q) answers[q] = (*this)(queries[q].first, queries[q].second);
+		};
+		constexpr size_t min_queries_per_thread = 1ULL<<12;
+		threads = std::max<size_t>(1, std::min(threads, queries.size() / min_queries_per_thread));
+		if(threads == 1) {
+			answer(0, queries.size());
+			return;
+		}
+		const size_t chunk = (queries.size() + threads - 1) / threads;
+		std::vector<std::thread> workers;
+		for(size_t begin = 0; begin < queries.size(); begin += chunk) {
+			workers.emplace_back(answer, begin, std::min(queries.size(), begin+chunk));
+		}
+		for(std::thread& worker : workers) worker.join();
+	}
+};
+
+#endif /* LCE_HPP */
@@ -0,0 +1,214 @@
+/**
+ * @file lcp_interval.hpp
+ * @brief Bottom-up enumeration of the LCP-intervals (virtual suffix tree)
+ *
+ * The internal nodes of the suffix tree correspond to the LCP-intervals of
+ * the suffix array. They are streamed with a stack in a single left-to-right
+ * scan over SA and LCP to a list of reducers, without building a tree.
+ */
+#ifndef LCP_INTERVAL_HPP
+#define LCP_INTERVAL_HPP
+
+#include <cstddef>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+/**
+ * An lcp-interval [lb,rb] with lcp-value lcp, i.e., an internal node of the suffix tree
+ * whose string depth is lcp and whose leaves are SA[lb..rb].
+ */
+struct LcpInterval {
+	size_t lcp;        //!< length of the longest common prefix of all suffixes in SA[lb..rb]
+	size_t lb;         //!< left boundary (inclusive)
+	size_t rb;         //!< right boundary (inclusive)
+	size_t parent_lcp; //!< lcp-value of the enclosing interval, zero for the root
+	bool left_diverse; //!< whether the characters preceding the suffixes in SA[lb..rb] differ (the BWT is not constant on [lb..rb])
+	bool has_child_interval; //!< whether there is a nested lcp-interval; if not, the interval is a local maximum
+
+	size_t size() const {
+		return rb - lb + 1;
+	}
+};
+
+/**
+ * Receives the lcp-intervals in the order they get closed, i.e., children before their parent.
+ */
+class LcpIntervalReducer {
+	public:
+	virtual ~LcpIntervalReducer() {}
+	/**
+	 * Called for each suffix SA[rank] when it gets attached to its parent interval.
+	 * @param length length of the suffix, not counting the delimiting $
+	 * @param parent_lcp lcp-value of the innermost interval containing the suffix
+	 */
+	virtual void leaf(size_t rank, size_t length, size_t parent_lcp) {
+		(void) rank; (void) length; (void) parent_lcp;
+	}
+	virtual void interval(const LcpInterval& iv) = 0;
+};
+
+/**
+ * Enumerates all lcp-intervals of the text bottom-up and hands them to each reducer.
+ * Works in O(n) time with a stack whose height is bounded by the height of the suffix tree.
+ *
+ * @param text the text on which sa was built. text.size() is the length without $
+ * @param sa the suffix array, possibly containing the $-suffix at rank 0
+ * @param lcp the LCP array of sa
+ * @param reducers the receivers of the intervals
+ */
+template<class string_type, class vektor_type>
+void traverse_lcp_intervals(const string_type& text, const vektor_type& sa, const vektor_type& lcp, const std::vector<LcpIntervalReducer*>& reducers) {
+	const size_t n = sa.size();
+	if(n == 0) return;
+	constexpr int unset = -1;
+	constexpr int diverse = -2;
+	constexpr int text_start = 256; //!< preceding character of the suffix starting at position 0, different to all characters
+
+	/** a partially built interval on the stack, rb is unknown until it gets closed */
+	struct Entry {
+		size_t lcp;
+		size_t lb;
+		int left_char;
+		bool has_child_interval;
+		void merge(int c) {
+			if(left_char == unset) left_char = c;
+			else if(left_char != c) left_char = diverse;
+		}
+	};
+	auto left_char = [&] (size_t rank) -> int {
+		const size_t pos = sa[rank];
+		return pos == 0 ? text_start : static_cast<unsigned char>(text[pos-1]);
+	};
+	auto emit = [&] (const Entry& e, size_t rb, size_t parent_lcp) {
+		const LcpInterval iv { e.lcp, e.lb, rb, parent_lcp, e.left_char == diverse, e.has_child_interval };
+		for(LcpIntervalReducer* reducer : reducers) reducer->interval(iv);
+	};
+
+	std::vector<Entry> stack;
+	stack.push_back(Entry { 0, 0, unset, false });
+	for(size_t i = 1; i <= n; ++i) {
+		const size_t current_lcp = i < n ? lcp[i] : 0;
+		{ // the leaf i-1 belongs to the innermost interval on the stack, or to the one that gets pushed
+			const size_t prev_lcp = i > 1 ? lcp[i-1] : 0;
+			const size_t parent_lcp = std::max<size_t>(prev_lcp, current_lcp);
+			const size_t length = text.size() - sa[i-1];
+			for(LcpIntervalReducer* reducer : reducers) reducer->leaf(i-1, length, parent_lcp);
+		}
+		const int leaf_char = left_char(i-1);
+		stack.back().merge(leaf_char);
+
+		size_t lb = i-1;
+		bool popped = false;
+		Entry last { 0, 0, unset, false };
+		while(current_lcp < stack.back().lcp) {
+			last = stack.back();
+			stack.pop_back();
+			DCHECK(!stack.empty());
+			Entry& top = stack.back();
+			emit(last, i-1, std::max<size_t>(current_lcp, top.lcp));
+			lb = last.lb;
+			popped = true;
+			if(current_lcp <= top.lcp) {
+				top.merge(last.left_char);
+				top.has_child_interval = true;
+			}
+		}
+		if(current_lcp > stack.back().lcp) {
+			Entry e { current_lcp, lb, unset, popped };
+			e.merge(popped ? last.left_char : leaf_char);
+			e.merge(leaf_char);
+			stack.push_back(e);
+		}
+	}
+	DCHECK_EQ(stack.size(), 1);
+	emit(stack.back(), n-1, 0);
+}
+
+/**
+ * Counts the distinct non-empty substrings of the text, i.e., the total edge length of the suffix tree.
+ */
+class DistinctSubstringsReducer : public LcpIntervalReducer {
+	size_t m_count = 0;
+	public:
+	virtual void leaf(size_t, size_t length, size_t parent_lcp) override {
+		if(length > parent_lcp) m_count += length - parent_lcp;
+	}
+	virtual void interval(const LcpInterval& iv) override {
+		m_count += iv.lcp - iv.parent_lcp;
+	}
+	size_t count() const {
+		return m_count;
+	}
+};
+
+/**
+ * Finds the longest factor occurring at least twice, i.e., the deepest internal node.
+ */
+class LongestRepeatedFactorReducer : public LcpIntervalReducer {
+	size_t m_length = 0;
+	size_t m_rank = 0;
+	public:
+	virtual void interval(const LcpInterval& iv) override {
+		if(iv.lcp > m_length) {
+			m_length = iv.lcp;
+			m_rank = iv.lb;
+		}
+	}
+	size_t length() const {
+		return m_length;
+	}
+	/**
+	 * @return rank in the suffix array of an occurrence, only meaningful if length() > 0
+	 */
+	size_t rank() const {
+		return m_rank;
+	}
+};
+
+/**
+ * Counts the maximal repeats, i.e., the left-diverse internal nodes except the root.
+ */
+class MaximalRepeatsReducer : public LcpIntervalReducer {
+	size_t m_count = 0;
+	public:
+	virtual void interval(const LcpInterval& iv) override {
+		if(iv.lcp > 0 && iv.left_diverse) ++m_count;
+	}
+	size_t count() const {
+		return m_count;
+	}
+};
+
+/**
+ * Counts the supermaximal repeats, i.e., the maximal repeats that do not occur as a substring of another maximal repeat.
+ * These are the local maximal lcp-intervals whose suffixes are preceded by pairwise different characters.
+ * @author Abouelhoda et al., "Replacing suffix trees with enhanced suffix arrays", JDA'04
+ */
+template<class string_type, class vektor_type>
+class SupermaximalRepeatsReducer : public LcpIntervalReducer {
+	const string_type& m_text;
+	const vektor_type& m_sa;
+	size_t m_count = 0;
+	public:
+	SupermaximalRepeatsReducer(const string_type& text, const vektor_type& sa)
+		: m_text(text), m_sa(sa)
+	{}
+	virtual void interval(const LcpInterval& iv) override {
+		if(iv.lcp == 0 || iv.has_child_interval || !iv.left_diverse) return;
+		// local maxima are disjoint, so these scans take O(n) time in total
+		bool seen[256] = {false};
+		for(size_t r = iv.lb; r <= iv.rb; ++r) {
+			if(m_sa[r] == 0) continue;
+			const unsigned char c = m_text[m_sa[r]-1];
+			if(seen[c]) return;
+			seen[c] = true;
+		}
+		++m_count;
+	}
+	size_t count() const {
+		return m_count;
+	}
+};
+
+#endif /* LCP_INTERVAL_HPP */
@@ -18,8 +18,17 @@
 #include <iostream>
 #include <functional>
 #include <algorithm>
+#include <numeric>
 #include "index_iterator.hpp"
 #include "arrayfunctional.hpp"
+#include "lcp_interval.hpp"
+#include "generalized_sa.hpp"
+#include "external_sa.hpp"
+#include "policy_allocator.hpp"
+#include "repetitions.hpp"
+#include <random>
+#include <chrono>
+#include <atomic>
 
 #include <gflags/gflags.h>
 DEFINE_uint64(threads, 4, "Number of Threads");
@@ -31,6 +40,17 @@ DEFINE_string(appendString, "", "Append a string to the sequence");
 DEFINE_string(prependString, "", "Prepend a string to the sequence");
 DEFINE_bool(stripDollar, false, "Strip the delimiting character of the string");
 DEFINE_bool(zeroindex, false, "Start counting indices at zero");
+DEFINE_uint64(batch, 0, "Number of generated strings sharing one generalized suffix array (0 = one suffix array per string)");
+DEFINE_string(external, "", "Build the suffix array and the LCP array of this file in external memory");
+DEFINE_string(externalOutput, "", "Prefix of the files .sa and .lcp written by -external, defaults to the input file");
+DEFINE_uint64(memory, 1024, "Memory budget in MiB for the external memory construction, bounding the size of the blocks sorted in RAM");
+DEFINE_string(tmpdir, "/tmp", "Directory for the temporary files of the external memory construction");
+DEFINE_string(hugepages, "none", "Page size of the index arrays: none, transparent or explicit");
+DEFINE_string(numa, "none", "NUMA placement of the index arrays: none, interleave or firsttouch (with -threads threads)");
+DEFINE_bool(timings, false, "Print the accumulated time spent in each construction stage");
+DEFINE_bool(runs, false, "Compute the Lyndon array and the runs");
+DEFINE_uint64(lceBenchmark, 0, "Number of random LCE queries to benchmark against character-wise comparisons");
+DEFINE_bool(intervals, false, "Compute suffix tree statistics by traversing the LCP-intervals");
 ///
 
 #define BOUNDS(x) x.begin(), x.end()
@@ -227,11 +247,45 @@ void print_ending() {
 
 
 
+/** 
+ * Construction stages whose running times are accumulated over all strings if FLAGS_timings is set
+ */
+enum class Stage { SA, ISA, LCP, LPF, psi, LF, count };
+const char*const stage_names[] = { "SA", "ISA", "LCP", "LPF", "psi", "LF" };
+std::atomic<uint64_t> stage_nanoseconds[static_cast<size_t>(Stage::count)];
+
+/** Adds the time of its lifetime to the stage */
+class StageTimer {
+	const Stage m_stage;
+	const std::chrono::steady_clock::time_point m_begin;
+	public:
+	StageTimer(Stage stage) 
+		: m_stage(stage), m_begin(FLAGS_timings ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point())
+	{}
+	~StageTimer() {
+		if(!FLAGS_timings) return;
+		stage_nanoseconds[static_cast<size_t>(m_stage)] += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_begin).count();
+	}
+};
+
+template<class F>
+auto timed(Stage stage, F f) -> decltype(f()) {
+	const StageTimer timer(stage);
+	return f();
+}
+
+void print_timings() {
+	if(!FLAGS_timings) return;
+	for(size_t i = 0; i < static_cast<size_t>(Stage::count); ++i) {
+		print_value((std::string("time ") + stage_names[i] + " [ms]").c_str(), stage_nanoseconds[i].load() / 1000000.0);
+	}
+}
+
 struct StringStats {
 #ifdef NDEBUG
-		typedef std::vector<int> vektor_type;
+		typedef std::vector<int, PolicyAllocator<int>> vektor_type;
 #else
-		typedef checked_vector<int> vektor_type;
+		typedef checked_vector<int, PolicyAllocator<int>> vektor_type;
 		//#define vektor_type sdsl::int_vector<>
 #endif
 
@@ -247,12 +301,25 @@ struct StringStats {
 
 	StringStats(const std::string&& ttext) 
 		: text(ttext)
-		, sa(create_sa<vektor_type>(text, FLAGS_stripDollar))
-		, isa(inverse<vektor_type>(sa))
-		, lcp(create_lcp<vektor_type>(text, sa, isa))
-		, lpf(create_lpf<vektor_type,vektor_type,vektor_type>(lcp, isa))
-		, psi(psi_array<vektor_type>(sa, isa))
-		, lf(lf_array<vektor_type>(sa, isa))
+		, sa (timed(Stage::SA,  [&] { return create_sa<vektor_type>(text, FLAGS_stripDollar); }))
+		, isa(timed(Stage::ISA, [&] { return inverse<vektor_type>(sa); }))
+		, lcp(timed(Stage::LCP, [&] { return create_lcp<vektor_type>(text, sa, isa); }))
+		, lpf(timed(Stage::LPF, [&] { return create_lpf<vektor_type,vektor_type,vektor_type>(lcp, isa); }))
+		, psi(timed(Stage::psi, [&] { return psi_array<vektor_type>(sa, isa); }))
+		, lf (timed(Stage::LF,  [&] { return lf_array<vektor_type>(sa, isa); }))
+	{
+	}
+	/** 
+	 * Takes the suffix array, its inverse and the LCP array from a previous construction, e.g., a GeneralizedSuffixArray
+	 */
+	StringStats(const std::string&& ttext, vektor_type&& ssa, vektor_type&& iisa, vektor_type&& llcp) 
+		: text(ttext)
+		, sa(std::move(ssa))
+		, isa(std::move(iisa))
+		, lcp(std::move(llcp))
+		, lpf(timed(Stage::LPF, [&] { return create_lpf<vektor_type,vektor_type,vektor_type>(lcp, isa); }))
+		, psi(timed(Stage::psi, [&] { return psi_array<vektor_type>(sa, isa); }))
+		, lf (timed(Stage::LF,  [&] { return lf_array<vektor_type>(sa, isa); }))
 	{
 	}
 	size_t size() const {
@@ -287,6 +354,98 @@ struct StringStats {
 		std::cout << "} " << std::endl;
 		print_value("rotation_order", rotation_order(sa,isa));
 		print_value("reverse_rotation_order", reverse_rotation_order(sa, isa)); 
+		if(FLAGS_intervals) print_intervals();
+		if(FLAGS_runs) print_runs(isZeroBasedNumbering);
+		if(FLAGS_lceBenchmark > 0) print_lce_benchmark(FLAGS_lceBenchmark);
+	}
+	/** 
+	 * Measures the throughput of single and batched (with -threads threads) LCE queries compared to comparing the characters like create_lcp.
+	 * The queries are random pairs of text positions with mostly short LCEs, 
+	 * and pairs of suffixes adjacent in the suffix array with the longest LCEs.
+	 */
+	void print_lce_benchmark(const size_t number_of_queries) const {
+		const size_t n = text.size();
+		if(n < 2) return;
+		typedef std::chrono::steady_clock clock;
+		auto milliseconds = [] (clock::time_point begin) { return std::chrono::duration<double, std::milli>(clock::now() - begin).count(); };
+		auto throughput = [&] (double ms) { return number_of_queries / (ms/1000.0) / 1000000.0; };
+
+		clock::time_point begin = clock::now();
+		const LceQuery<vektor_type> lce(lcp, isa, n);
+		print_value("lce_construction [ms]", milliseconds(begin));
+
+		auto run = [&] (const std::string& workload, const std::vector<std::pair<size_t,size_t>>& queries) {
+			size_t checksum_naive = 0;
+			begin = clock::now();
+			for(const auto& query : queries) {
+				size_t h = 0;
+				while(query.first+h < n && query.second+h < n && text[query.first+h] == text[query.second+h]) ++h;
+				checksum_naive += h;
+			}
+			print_value(("lce_naive_" + workload + " [Mq/s]").c_str(), throughput(milliseconds(begin)));
+
+			size_t checksum_single = 0;
+			begin = clock::now();
+			for(const auto& query : queries) checksum_single += lce(query.first, query.second);
+			print_value(("lce_single_" + workload + " [Mq/s]").c_str(), throughput(milliseconds(begin)));
+
+			std::vector<size_t> answers;
+			begin = clock::now();
+			lce(queries, answers, FLAGS_threads);
+			const size_t checksum_batched = std::accumulate(answers.begin(), answers.end(), size_t(0));
+			print_value(("lce_batched_" + workload + " [Mq/s]").c_str(), throughput(milliseconds(begin)));
+			CHECK_EQ(checksum_naive, checksum_single);
+			CHECK_EQ(checksum_naive, checksum_batched);
+		};
+
+		std::mt19937_64 random(n);
+		std::vector<std::pair<size_t,size_t>> queries(number_of_queries);
+		for(auto& query : queries) query = std::make_pair(random() % n, random() % n);
+		run("random", queries);
+		const size_t first = size() - n; // skips the $
+		for(auto& query : queries) {
+			const size_t r = first + random() % (n-1);
+			query = std::make_pair(sa[r], sa[r+1]);
+		}
+		run("adjacent", queries);
+	}
+	/** 
+	 * Prints the Lyndon array and the runs. The longest common suffixes needed for the runs
+	 * are answered by the LCP array of the reversed text.
+	 */
+	void print_runs(const bool isZeroBasedNumbering = true) const {
+		const size_t n = text.size();
+		const size_t setwidth = static_cast<size_t>(std::log10(n+1)) +1;
+		const std::string reversed(text.rbegin(), text.rend());
+		const vektor_type reversed_sa = create_sa<vektor_type>(reversed, false);
+		const vektor_type reversed_isa = inverse<vektor_type>(reversed_sa);
+		const vektor_type reversed_lcp = create_lcp<vektor_type>(reversed, reversed_sa, reversed_isa);
+		const LceQuery<vektor_type> lce(lcp, isa, n);
+		const LceQuery<vektor_type> reversed_lce(reversed_lcp, reversed_isa, n);
+
+		const vektor_type lyndon = lyndon_array<vektor_type>(isa, n);
+		print_array(setwidth, "LYN", lyndon);
+		const std::vector<Run> runs = compute_runs<vektor_type>(text, lyndon, lce, reversed_lce, n);
+		std::cout << "runs : { ";
+		for(const Run& run : runs) {
+			std::cout << "[" << (isZeroBasedNumbering ? 0 : 1) + run.begin << "," << (isZeroBasedNumbering ? 0 : 1) + run.end - 1 << "]^" << run.period << ", ";
+		}
+		std::cout << "} " << std::endl;
+		print_value("number_of_runs", runs.size());
+	}
+	/** 
+	 * Prints the statistics gathered in one traversal of the LCP-intervals
+	 */
+	void print_intervals() const {
+		DistinctSubstringsReducer distinct;
+		LongestRepeatedFactorReducer longest;
+		MaximalRepeatsReducer maximal;
+		SupermaximalRepeatsReducer<std::string, vektor_type> supermaximal(text, sa);
+		traverse_lcp_intervals(text, sa, lcp, { &distinct, &longest, &maximal, &supermaximal });
+		print_value("distinct_substrings", distinct.count());
+		print_value("longest_repeated_factor", longest.length() == 0 ? std::string() : text.substr(sa[longest.rank()], longest.length()));
+		print_value("maximal_repeats", maximal.count());
+		print_value("supermaximal_repeats", supermaximal.count());
 	}
 };
 
@@ -315,6 +474,52 @@ void map_parallel(
 	}
 }
 
+/** 
+ * Like map_parallel, but each thread claims a block of batch indices,
+ * and builds a single GeneralizedSuffixArray for all strings in the block, reusing its buffers for the next block.
+ */
+void map_parallel_batched(
+		std::function<std::string(size_t)> generator, 
+		const size_t left, const size_t right, const size_t batch,
+		std::function<void(size_t, const StringStats&)> mapto
+		) {
+	std::vector<std::thread> threads(FLAGS_threads);
+	std::atomic_size_t index(left);
+	auto runnable = [&] () {
+		std::vector<std::string> texts;
+		std::vector<size_t> indices;
+		std::vector<StringStats::vektor_type> sas;
+		std::vector<StringStats::vektor_type> isas;
+		std::vector<StringStats::vektor_type> lcps;
+		GeneralizedSuffixArray<StringStats::vektor_type> gsa;
+		while(index.load() < right) {
+			const size_t first = index.fetch_add(batch)+1;
+			if(first > right) break;
+			const size_t last = std::min(first+batch, right+1);
+			texts.clear();
+			indices.clear();
+			for(size_t mindex = first; mindex < last; ++mindex) {
+				std::string text = generator(mindex);
+				if(text.empty()) continue;
+				texts.push_back(std::move(text));
+				indices.push_back(mindex);
+			}
+			timed(Stage::SA, [&] { gsa.construct(texts); });
+			timed(Stage::LCP, [&] { gsa.split(FLAGS_stripDollar, sas, isas, lcps); }); // includes the ISA of each string
+			for(size_t k = 0; k < texts.size(); ++k) {
+				const StringStats stats(std::move(texts[k]), std::move(sas[k]), std::move(isas[k]), std::move(lcps[k]));
+				mapto(indices[k], stats);
+			}
+		}};
+
+	for(size_t i = 0; i < FLAGS_threads; ++i) {
+		threads[i] = std::thread(runnable);
+	}
+	for(auto& thread : threads) {
+		thread.join();
+	}
+}
+
 
 /**
  * Creates a standard word by a binary number.
@@ -459,8 +664,23 @@ int main(int argc, char **argv)
 		SetUsageMessage(usage_message);
 		ParseCommandLineFlags(&argc, &argv, true);
 	}
+	{
+		AllocationPolicy& policy = allocation_policy();
+		policy.threads = FLAGS_threads;
+		if(!policy.parse_pages(FLAGS_hugepages) || !policy.parse_numa(FLAGS_numa)) {
+			help(argv[0]);
+			return 0;
+		}
+	}
+	if(!FLAGS_external.empty()) {
+		construct_external_sa(FLAGS_external, 
+				FLAGS_externalOutput.empty() ? FLAGS_external : FLAGS_externalOutput,
+				FLAGS_memory<<20, FLAGS_tmpdir, FLAGS_stripDollar);
+		return EXIT_SUCCESS;
+	}
 	if(!FLAGS_ex.empty()) {
 		StringStats(std::move(FLAGS_ex)).print(FLAGS_zeroindex);
+		print_timings();
 		return EXIT_SUCCESS;
 	}
 	std::function<std::string(size_t)> generator = intToString;
@@ -489,6 +709,7 @@ int main(int argc, char **argv)
 	} else {
 		if(argc > 1) {
 			StringStats(std::move(argv[1])).print(FLAGS_zeroindex);
+			print_timings();
 			return EXIT_SUCCESS;
 		}
 
@@ -503,13 +724,7 @@ int main(int argc, char **argv)
 		generator = Prepender(std::move(generator), FLAGS_prependString);
 
 	std::mutex mutexOutput;
-	map_parallel(
-			generator,
-			FLAGS_minlimit,
-			FLAGS_maxlimit,
-			[&mutexOutput] (size_t index, std::string& str) {
-				if(str.empty()) return;
-				const StringStats stats = StringStats(std::move(str));
+	auto report = [&mutexOutput] (size_t index, const StringStats& stats) {
 				if(stats.size() == 0) return;
 				// const int rotation = rotation_order(stats.sa,stats.isa);
 				// const int reverse_rotation = reverse_rotation_order(stats.sa,stats.isa);
@@ -520,6 +735,19 @@ int main(int argc, char **argv)
 					stats.print(FLAGS_zeroindex);
 					print_ending();
 				}
+			};
+	if(FLAGS_batch > 0) {
+		map_parallel_batched(generator, FLAGS_minlimit, FLAGS_maxlimit, FLAGS_batch, report);
+		print_timings();
+		return EXIT_SUCCESS;
+	}
+	map_parallel(
+			generator,
+			FLAGS_minlimit,
+			FLAGS_maxlimit,
+			[&report] (size_t index, std::string& str) {
+				if(str.empty()) return;
+				report(index, StringStats(std::move(str)));
 
 			/* 
 				if(str.empty()) return;
@@ -541,6 +769,7 @@ int main(int argc, char **argv)
 				}
 				*/
 			});
+	print_timings();
 
 	/*
 	map_parallel(
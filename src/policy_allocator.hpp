@@ -0,0 +1,168 @@
+/**
+ * @file policy_allocator.hpp
+ * @brief Allocator placing large arrays on huge pages and/or across NUMA nodes
+ *
+ * The policy is selected at runtime by setting allocation_policy() before any array is allocated.
+ * Each allocator remembers the policy it was created with, such that it frees its memory accordingly.
+ * Arrays smaller than a huge page are always taken from operator new.
+ */
+#ifndef POLICY_ALLOCATOR_HPP
+#define POLICY_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+struct AllocationPolicy {
+	enum class Pages {
+		standard,    //!< 4 KB pages
+		transparent, //!< transparent huge pages requested by madvise
+		hugetlb      //!< explicit huge pages by mmap, falls back to transparent huge pages if none are reserved
+	};
+	enum class Numa {
+		standard,    //!< pages land on the node of the thread touching them first
+		interleave,  //!< pages are interleaved round-robin over all allowed nodes
+		first_touch  //!< pages are touched in parallel by `threads` threads
+	};
+	Pages pages = Pages::standard;
+	Numa numa = Numa::standard;
+	size_t threads = 1;
+
+	bool uses_mmap() const {
+		return pages != Pages::standard || numa != Numa::standard;
+	}
+	/**
+	 * @return false if name is none of "none", "transparent" or "explicit"
+	 */
+	bool parse_pages(const std::string& name) {
+		if(name == "none") pages = Pages::standard;
+		else if(name == "transparent") pages = Pages::transparent;
+		else if(name == "explicit") pages = Pages::hugetlb;
+		else return false;
+		return true;
+	}
+	/**
+	 * @return false if name is none of "none", "interleave" or "firsttouch"
+	 */
+	bool parse_numa(const std::string& name) {
+		if(name == "none") numa = Numa::standard;
+		else if(name == "interleave") numa = Numa::interleave;
+		else if(name == "firsttouch") numa = Numa::first_touch;
+		else return false;
+		return true;
+	}
+};
+
+/**
+ * The policy used by all PolicyAllocators created from now on
+ */
+inline AllocationPolicy& allocation_policy() {
+	static AllocationPolicy policy;
+	return policy;
+}
+
+namespace policy_allocator_private {
+	constexpr size_t hugepage_size = 2ULL<<20;
+	constexpr int mpol_interleave = 3;            //!< MPOL_INTERLEAVE of numaif.h
+	constexpr unsigned long mpol_f_mems_allowed = 1<<2; //!< MPOL_F_MEMS_ALLOWED of numaif.h
+
+	inline size_t mapped_length(size_t bytes) {
+		return (bytes + hugepage_size - 1) / hugepage_size * hugepage_size;
+	}
+
+	/** maps length bytes aligned to a huge page boundary such that the kernel can back it with transparent huge pages */
+	inline void* map_aligned(size_t length) {
+		void* raw = mmap(nullptr, length + hugepage_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if(raw == MAP_FAILED) return raw;
+		const uintptr_t address = reinterpret_cast<uintptr_t>(raw);
+		const uintptr_t aligned = (address + hugepage_size - 1) / hugepage_size * hugepage_size;
+		const size_t head = aligned - address;
+		if(head > 0) munmap(raw, head);
+		if(hugepage_size - head > 0) munmap(reinterpret_cast<char*>(aligned) + length, hugepage_size - head);
+		return reinterpret_cast<void*>(aligned);
+	}
+
+	/** binds the memory interleaved to all nodes we are allowed to use. Done by syscalls to not depend on libnuma */
+	inline void interleave(void* data, size_t length) {
+		unsigned long nodes[16] = {0};
+		const unsigned long maxnode = sizeof(nodes)*8;
+		int mode;
+		if(syscall(SYS_get_mempolicy, &mode, nodes, maxnode, nullptr, mpol_f_mems_allowed) != 0
+		|| syscall(SYS_mbind, data, length, mpol_interleave, nodes, maxnode, 0) != 0) {
+			VLOG(1) << "Could not interleave " << length << " bytes over the NUMA nodes";
+		}
+	}
+
+	/** writes zeros to data, split evenly among the given number of threads */
+	inline void touch_in_parallel(void* data, size_t length, size_t threads) {
+		threads = std::max<size_t>(1, std::min(threads, length / hugepage_size));
+		const size_t chunk = mapped_length(length / threads);
+		std::vector<std::thread> workers;
+		for(size_t begin = 0; begin < length; begin += chunk) {
+			workers.emplace_back([=] () { std::memset(static_cast<char*>(data) + begin, 0, std::min(chunk, length - begin)); });
+		}
+		for(std::thread& worker : workers) worker.join();
+	}
+}
+
+template<class T>
+class PolicyAllocator {
+	template<class U> friend class PolicyAllocator;
+	AllocationPolicy m_policy;
+
+	public:
+	typedef T value_type;
+
+	PolicyAllocator() : m_policy(allocation_policy()) {}
+	template<class U>
+	PolicyAllocator(const PolicyAllocator<U>& other) : m_policy(other.m_policy) {}
+
+	T* allocate(size_t n) {
+		using namespace policy_allocator_private;
+		const size_t bytes = n*sizeof(T);
+		if(!maps(bytes)) return static_cast<T*>(::operator new(bytes));
+		const size_t length = mapped_length(bytes);
+		void* data = MAP_FAILED;
+		if(m_policy.pages == AllocationPolicy::Pages::hugetlb) {
+			data = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+			if(data == MAP_FAILED) VLOG(1) << "No explicit huge pages available for " << length << " bytes, using transparent huge pages";
+		}
+		if(data == MAP_FAILED) {
+			data = map_aligned(length);
+			if(data == MAP_FAILED) throw std::bad_alloc();
+			if(m_policy.pages != AllocationPolicy::Pages::standard) madvise(data, length, MADV_HUGEPAGE);
+		}
+		if(m_policy.numa == AllocationPolicy::Numa::interleave) interleave(data, length);
+		else if(m_policy.numa == AllocationPolicy::Numa::first_touch) touch_in_parallel(data, length, m_policy.threads);
+		return static_cast<T*>(data);
+	}
+	void deallocate(T* p, size_t n) {
+		const size_t bytes = n*sizeof(T);
+		if(!maps(bytes)) ::operator delete(p);
+		else munmap(p, policy_allocator_private::mapped_length(bytes));
+	}
+
+	template<class U>
+	bool operator==(const PolicyAllocator<U>& other) const {
+		return m_policy.pages == other.m_policy.pages && m_policy.numa == other.m_policy.numa;
+	}
+	template<class U>
+	bool operator!=(const PolicyAllocator<U>& other) const {
+		return !(*this == other);
+	}
+
+	private:
+	bool maps(size_t bytes) const {
+		return m_policy.uses_mmap() && bytes >= policy_allocator_private::hugepage_size;
+	}
+};
+
+#endif /* POLICY_ALLOCATOR_HPP */
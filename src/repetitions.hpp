@@ -0,0 +1,108 @@
+/**
+ * @file repetitions.hpp
+ * @brief Lyndon array and runs (maximal repetitions) in linear time
+ *
+ * Every run has an L-root that is the longest Lyndon word starting at its position
+ * with respect to the standard order or to the inverted order of the alphabet.
+ * So the runs are found by checking the longest Lyndon word starting at each position,
+ * extending it with LCE queries to the right and to the left.
+ * @author Bannai et al., "The Runs Theorem", SICOMP'17
+ */
+#ifndef REPETITIONS_HPP
+#define REPETITIONS_HPP
+
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+#include <tuple>
+#include "lce.hpp"
+
+/** A run T[begin..end) with smallest period `period`, where end-begin >= 2*period */
+struct Run {
+	size_t begin;
+	size_t end;
+	size_t period;
+
+	bool operator<(const Run& other) const {
+		return std::tie(begin, end, period) < std::tie(other.begin, other.end, other.period);
+	}
+	bool operator==(const Run& other) const {
+		return begin == other.begin && end == other.end && period == other.period;
+	}
+};
+
+/**
+ * Computes the Lyndon array, i.e., the length of the longest Lyndon word starting at each text position.
+ * This is the distance to the next smaller suffix, computed from right to left by
+ * jumping over the Lyndon words already known.
+ *
+ * @param n the length of the text without $
+ * @param smaller smaller(j,i) tells whether T[j..] is lexicographically smaller than T[i..]
+ */
+template<class vektor_type, class Compare>
+vektor_type lyndon_array_from(size_t n, Compare smaller) {
+	vektor_type lyndon(n);
+	for(size_t i = n; i > 0; --i) {
+		size_t j = i;
+		while(j < n && !smaller(j, i-1)) j += lyndon[j];
+		lyndon[i-1] = j - (i-1);
+	}
+	return lyndon;
+}
+
+/**
+ * Lyndon array with respect to the standard order, read from the inverse suffix array
+ */
+template<class vektor_type>
+vektor_type lyndon_array(const vektor_type& isa, size_t n) {
+	return lyndon_array_from<vektor_type>(n, [&isa] (size_t j, size_t i) { return isa[j] < isa[i]; });
+}
+
+/**
+ * Lyndon array with respect to the inverted order of the alphabet, where the end of the text stays the smallest symbol.
+ * The suffixes are compared with LCE queries.
+ */
+template<class vektor_type, class string_type>
+vektor_type inverted_lyndon_array(const string_type& text, const LceQuery<vektor_type>& lce, size_t n) {
+	return lyndon_array_from<vektor_type>(n, [&] (size_t j, size_t i) {
+		const size_t l = lce(i, j);
+		if(j+l == n) return true;
+		if(i+l == n) return false;
+		return static_cast<unsigned char>(text[j+l]) > static_cast<unsigned char>(text[i+l]);
+	});
+}
+
+/**
+ * Computes all runs of the text, sorted by their starting positions.
+ * A run is reported at its leftmost L-root only.
+ *
+ * @param text the text of length n
+ * @param lyndon the Lyndon array of text with respect to the standard order, see lyndon_array
+ * @param lce LCE queries on text
+ * @param reversed_lce LCE queries on the reversed text, answering the longest common suffixes
+ * @param n the length of the text without $
+ */
+template<class vektor_type, class string_type>
+std::vector<Run> compute_runs(const string_type& text, const vektor_type& lyndon, const LceQuery<vektor_type>& lce, const LceQuery<vektor_type>& reversed_lce, size_t n) {
+	std::vector<Run> runs;
+	// longest common suffix of T[..i] and T[..j]
+	auto lcs = [&] (size_t i, size_t j) { return reversed_lce(n-1-i, n-1-j); };
+	auto collect = [&] (const vektor_type& lyndon_order) {
+		for(size_t i = 0; i < n; ++i) {
+			const size_t p = lyndon_order[i];
+			if(i + p >= n) continue;
+			const size_t right = lce(i, i+p);
+			if(right == 0) continue;
+			if(i >= p && lce(i-p, i) >= p) continue; // not the leftmost L-root
+			const size_t left = i > 0 ? lcs(i-1, i+p-1) : 0;
+			if(left + right >= p) runs.push_back(Run { i-left, i+p+right, p });
+		}
+	};
+	collect(lyndon);
+	collect(inverted_lyndon_array<vektor_type>(text, lce, n));
+	std::sort(runs.begin(), runs.end());
+	runs.erase(std::unique(runs.begin(), runs.end()), runs.end());
+	return runs;
+}
+
+#endif /* REPETITIONS_HPP */